@@ -17,6 +17,7 @@
   *       hBmp --> Background image, the drawing range is the same as the size of the background image
   *       dwTime --> Refresh interval (milliseconds), recommended value: 10~30
   *       dwType --> =0 indicates circular water ripples, =1 indicates elliptical water ripples (used for perspective effects)
+  *                  OR with WAVE_TYPE_TILED (=2) to store the wave buffers in 64x16 tiles (see 5. below)
   *       Return value: 0 (success, object initialized), 1 (failure)
   */
 
@@ -48,6 +49,14 @@
    *                    Param1 = Density (larger is denser), recommended value: 50~300
    *                    Param2 = Size, recommended value: 2~5
    *                    Param3 = Energy, recommended value: 5~10
+   *             4 --> Rain curtain (a band of heavy rain crossing the image):
+   *                    Param1 = Raindrops per refresh, recommended value: 1~10
+   *                    Param2 = Maximum raindrop diameter, recommended value: 0~5
+   *                    Param3 = Maximum raindrop weight, recommended value: 50~250
+   *             5 --> Several motorboats:
+   *                    Param1 = Number of boats, 1~WAVE_BOATS_MAX (=16)
+   *                    Param2 = Boat size, recommended value: 0~4
+   *                    Param3 = Range of water ripple diffusion, recommended value: 100~500
    *
    *    c) Force update of the window client area (used to force update the client area in the window's WM_PAINT message):
    *     case WM_PAINT:
@@ -60,6 +69,19 @@
    *        _WaveUpdateFrame(&stWaveObj, updelete, TRUE);
    *        EndPaint(hWin, &stPs);
    *        return 0;
+   *
+   *    d) Replace the background image by a video stream:
+   *       _WaveStreamOpen(&lpWaveObject, szFile, dwFormat);
+   *          szFile --> File to read, NULL reads the standard input,
+   *                     \\.\pipe\<name> creates the named pipe <name> and waits for a writer to connect to it
+   *          dwFormat --> WAVE_STREAM_RAW: raw BGR24 frames, top-down, same size as the background image
+   *                       WAVE_STREAM_Y4M: YUV4MPEG2 stream (8 bit 4:2:0), same size as the background image
+   *                       e.g. _WaveStreamOpen(&stWaveObj, _T("\\\\.\\pipe\\ripple"), WAVE_STREAM_Y4M), then
+   *                       ffmpeg -i video.mp4 -s 320x240 -pix_fmt yuv420p -f yuv4mpegpipe \\.\pipe\ripple
+   *          Return value: 0 (success, stream started), 1 (failure)
+   *       A producer thread decodes the frames into WAVE_STREAM_RING pre-allocated buffers, each timer tick
+   *       displays the next decoded frame if there is one. Files are played in a loop, pipes until they are closed.
+   *       _WaveStreamClose(&lpWaveObject) stops the stream and restores the background image (also done by _WaveFree).
    */
 
    /**
@@ -92,6 +114,21 @@
     *
     * 4. The algorithm for throwing stones is easy to understand. Set the energy value of a certain point in Wave1 to a non-zero value;
     *    the larger the value, the greater the energy of the stone thrown. If the stone is large, set all the points around that point to a non-zero value.
+    *
+    * 5. By default Wave1 and Wave2 are row-major (index = y * dwBmpWidth + x), so the neighbours at y-1 and y+1 used by
+    *    _WaveSpread and _WaveRender are a whole image row away: on wide images each one is another cache line and often another page.
+    *    With WAVE_TYPE_TILED the buffers are cut into 64x16 tiles stored one after the other (4 KB each, i.e. one page),
+    *    and each tile is row-major inside. _WaveSpread walks the image tile by tile, _WaveRender walks it line by line
+    *    across the tile columns (its pixel buffers stay row-major). For each line of a tile the lines above and below are
+    *    read in place (from the tile above / below for the first / last line), and the line itself is copied with a halo
+    *    of 1~3 points taken from the tiles on the left and right (_WaveTileHalo).
+    *    At the image borders the halo holds what the row-major code reads there (end of the previous line, start of the
+    *    next one), so both layouts give exactly the same ripples.
+    *    Only the wave buffers are tiled, the pixel buffers keep the DIB layout, so the conversion is done by _WaveRender.
+    *    _WaveDropStone addresses the buffers through _WaveIndex, which handles both layouts.
+    *    wave_bench.c times _WaveSpread and _WaveRender with both layouts and checks that they give the same result.
+    *    Whether the tiles pay off depends on the machine: measure with wave_bench (and a profiler for the cache / TLB
+    *    misses) before choosing WAVE_TYPE_TILED.
     *********************************************************************************/
 
 #pragma warning( disable : 4146)
@@ -99,6 +136,10 @@
 #include <stdint.h>
 #include <windows.h>
 #include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+#include <tchar.h>
+#include <emmintrin.h>
 #include "water_ripple.h"
 
 #ifndef WAVEOBJ_INC
@@ -109,6 +150,17 @@
 #define F_WO_NEED_UPDATE  0x0002
 #define F_WO_EFFECT       0x0004
 #define F_WO_ELLIPSE      0x0008
+#define F_WO_TILED        0x0010
+#define F_WO_STREAM       0x0020
+#define F_WO_STREAM_FRAME 0x0040   // lpDIBitsSource points to a frame of lpStreamRing
+#define F_WO_STREAM_SERVER 0x0080  // hStreamFile is the server end of a named pipe
+
+// Tiled layout: 64x16 points per tile, 4 bytes per point = 4 KB per tile
+#define TILE_SHIFT_X      6
+#define TILE_SHIFT_Y      4
+#define TILE_W            (1 << TILE_SHIFT_X)
+#define TILE_H            (1 << TILE_SHIFT_Y)
+#define TILE_SIZE         (TILE_W * TILE_H)
 
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 // Random Number Generation Subroutine
@@ -141,6 +193,149 @@ uint32_t _WaveRandom(WAVE_OBJECT* lpWaveObject, uint32_t dwMax) {
     return result;
 }
 
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Batch Random Number Generation (SSE2)
+// Fills lpOut[0..dwCount) with random numbers in [0, dwMax), used by the effects instead of _WaveRandom.
+// There are WAVE_RANDOM_LANES (= 8, two SSE2 registers) independent streams, lane n produces lpOut[n], lpOut[n + 8], ...
+// 1. Each lane: Rnd = Rnd * 1664525 + 1013904223 (mod 2^32). SSE2 has no 32 bit multiply, it is done with
+//    _mm_mul_epu32 (32 x 32 -> 64 bit) on the even lanes and on the odd lanes shifted down, keeping the low halves.
+// 2. Range: (Rnd * dwMax) >> 32 instead of Rnd % dwMax, same two _mm_mul_epu32 keeping the high halves.
+//    Keeps the high bits (the good ones of this generator) and needs no division.
+// lpOut is written by groups of WAVE_RANDOM_LANES, it must hold dwCount rounded up to a multiple of it.
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Low 32 bits of a * b in each 32 bit lane
+__m128i _WaveMulLo32(__m128i a, __m128i b) {
+    __m128i even = _mm_mul_epu32(a, b);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), _mm_srli_epi64(b, 32));
+    return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, _MM_SHUFFLE(0, 0, 2, 0)), _mm_shuffle_epi32(odd, _MM_SHUFFLE(0, 0, 2, 0)));
+}
+
+// High 32 bits of a * dwMax in each 32 bit lane (max holds dwMax in every lane)
+__m128i _WaveMulHi32(__m128i a, __m128i max) {
+    __m128i even = _mm_mul_epu32(a, max);
+    __m128i odd = _mm_mul_epu32(_mm_srli_epi64(a, 32), max);
+    return _mm_or_si128(_mm_srli_epi64(even, 32), _mm_and_si128(odd, _mm_set_epi32(-1, 0, -1, 0)));
+}
+
+void _WaveRandomBatch(WAVE_OBJECT* lpWaveObject, uint32_t* lpOut, uint32_t dwCount, uint32_t dwMax) {
+    __m128i mul = _mm_set1_epi32(1664525);
+    __m128i add = _mm_set1_epi32(1013904223);
+    __m128i max = _mm_set1_epi32(dwMax);
+    __m128i lanes0 = _mm_loadu_si128((__m128i*)&lpWaveObject->dwRandomLanes[0]);
+    __m128i lanes1 = _mm_loadu_si128((__m128i*)&lpWaveObject->dwRandomLanes[4]);
+
+    for (uint32_t i = 0; i < dwCount; i += WAVE_RANDOM_LANES) {
+        lanes0 = _mm_add_epi32(_WaveMulLo32(lanes0, mul), add);
+        lanes1 = _mm_add_epi32(_WaveMulLo32(lanes1, mul), add);
+        _mm_storeu_si128((__m128i*)&lpOut[i], _WaveMulHi32(lanes0, max));
+        _mm_storeu_si128((__m128i*)&lpOut[i + 4], _WaveMulHi32(lanes1, max));
+    }
+
+    _mm_storeu_si128((__m128i*)&lpWaveObject->dwRandomLanes[0], lanes0);
+    _mm_storeu_si128((__m128i*)&lpWaveObject->dwRandomLanes[4], lanes1);
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Index of point (x, y) in the wave buffers
+// Row-major: y * dwBmpWidth + x
+// Tiled:     tile (x / 64, y / 16) * 1024 + (y % 16) * 64 + (x % 64)
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+uint32_t _WaveIndex(WAVE_OBJECT* lpWaveObject, uint32_t x, uint32_t y) {
+    if (!(lpWaveObject->dwFlag & F_WO_TILED))
+        return y * lpWaveObject->dwBmpWidth + x;
+
+    uint32_t tile = (y >> TILE_SHIFT_Y) * lpWaveObject->dwTileCols + (x >> TILE_SHIFT_X);
+    return (tile << (TILE_SHIFT_X + TILE_SHIFT_Y)) + ((y & (TILE_H - 1)) << TILE_SHIFT_X) + (x & (TILE_W - 1));
+}
+
+// Start of line y of tile column tx (tiled layout only)
+uint32_t* _WaveTileLine(WAVE_OBJECT* lpWaveObject, uint32_t* wave, uint32_t tx, uint32_t y) {
+    uint32_t tile = (y >> TILE_SHIFT_Y) * lpWaveObject->dwTileCols + tx;
+    return wave + (tile << (TILE_SHIFT_X + TILE_SHIFT_Y)) + ((y & (TILE_H - 1)) << TILE_SHIFT_X);
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Copy line y of tile column tx to lpLine[0..count) with a halo of dwHalo points on each side,
+// taken from the tiles on the left and on the right.
+// At the image borders the halo holds what the row-major index i - k / i + k reads:
+// the end of line y - 1 on the left, the start of line y + 1 on the right.
+// Return: count, the number of points of the tile inside the image
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+uint32_t _WaveTileHalo(WAVE_OBJECT* lpWaveObject, uint32_t* wave, uint32_t tx, uint32_t y, uint32_t* lpLine, uint32_t dwHalo) {
+    uint32_t width = lpWaveObject->dwBmpWidth;
+    uint32_t lastTx = lpWaveObject->dwTileCols - 1;
+    uint32_t count = (tx == lastTx) ? width - (lastTx << TILE_SHIFT_X) : TILE_W;
+    uint32_t* line = _WaveTileLine(lpWaveObject, wave, tx, y);
+
+    CopyMemory(lpLine, line, count * sizeof(uint32_t));
+
+    for (uint32_t k = 1; k <= dwHalo; ++k)
+        lpLine[-(int32_t)k] = tx ? (line - TILE_SIZE)[TILE_W - k] : wave[_WaveIndex(lpWaveObject, width - k, y - 1)];
+
+    for (uint32_t k = 0; k < dwHalo; ++k) {
+        uint32_t x = (tx << TILE_SHIFT_X) + count + k;
+        lpLine[count + k] = (x < width) ? line[TILE_SIZE + k] : wave[_WaveIndex(lpWaveObject, x - width, y + 1)];
+    }
+
+    return count;
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Wave Energy Diffusion, tiled layout
+// Same algorithm and same result as _WaveSpread, walked tile by tile.
+// For each line of a tile: the lines above and below are read in place (in the tile above / below
+// for the first / last line of the tile), the line itself is copied with its halo by _WaveTileHalo,
+// so the inner loops have no test on the position.
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void _WaveSpreadTiled(WAVE_OBJECT* lpWaveObject, uint32_t* wave1, uint32_t* wave2) {
+    uint32_t height = lpWaveObject->dwBmpHeight;
+    bool ellipse = (lpWaveObject->dwFlag & F_WO_ELLIPSE) != 0;
+    uint32_t halo[3 + TILE_W + 3];
+    uint32_t* cur = halo + 3;
+
+    for (uint32_t ty = 0; ty < lpWaveObject->dwTileRows; ++ty) {
+        for (uint32_t tx = 0; tx < lpWaveObject->dwTileCols; ++tx) {
+            for (uint32_t ly = 0; ly < TILE_H; ++ly) {
+                uint32_t y = (ty << TILE_SHIFT_Y) + ly;
+                if (y < 1) continue;
+                if (y >= height - 1) break;
+
+                uint32_t* line = _WaveTileLine(lpWaveObject, wave1, tx, y);
+                uint32_t* prev = ly ? line - TILE_W : _WaveTileLine(lpWaveObject, wave1, tx, y - 1);
+                uint32_t* next = (ly + 1 < TILE_H) ? line + TILE_W : _WaveTileLine(lpWaveObject, wave1, tx, y + 1);
+                uint32_t* __restrict out = _WaveTileLine(lpWaveObject, wave2, tx, y);
+                uint32_t count = _WaveTileHalo(lpWaveObject, wave1, tx, y, cur, ellipse ? 3 : 1);
+
+                if (ellipse) {
+                    for (int32_t lx = 0; lx < (int32_t)count; ++lx) {
+                        int32_t value = 3 * (cur[lx - 1] + cur[lx + 1]) +
+                            2 * (cur[lx - 2] + cur[lx + 2]) +
+                            2 * (cur[lx - 3] + cur[lx + 3]) +
+                            8 * (prev[lx] + next[lx]);
+                        value = (value >> 4) - out[lx];
+
+                        int32_t delta = value >> 5;
+                        value -= delta;
+
+                        out[lx] = value;
+                    }
+                }
+                else {
+                    for (int32_t lx = 0; lx < (int32_t)count; ++lx) {
+                        int32_t value = cur[lx - 1] + cur[lx + 1] + prev[lx] + next[lx];
+                        value = (value >> 1) - out[lx];
+
+                        int32_t delta = value >> 5;
+                        value -= delta;
+
+                        out[lx] = value;
+                    }
+                }
+            }
+        }
+    }
+}
+
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 // Wave Energy Diffusion
 // Algorithm:
@@ -158,31 +353,36 @@ void _WaveSpread(WAVE_OBJECT* lpWaveObject) {
     uint32_t maxIndex = (height - 1) * width;
     uint32_t i = lpWaveObject->dwBmpWidth;
 
-    while (i < maxIndex) {
-        if (lpWaveObject->dwFlag & F_WO_ELLIPSE) {
-            int32_t value = 3 * (wave1[i - 1] + wave1[i + 1]) +
-                2 * (wave1[i - 2] + wave1[i + 2]) +
-                2 * (wave1[i - 3] + wave1[i + 3]);
+    if (lpWaveObject->dwFlag & F_WO_TILED) {
+        _WaveSpreadTiled(lpWaveObject, wave1, wave2);
+    }
+    else {
+        while (i < maxIndex) {
+            if (lpWaveObject->dwFlag & F_WO_ELLIPSE) {
+                int32_t value = 3 * (wave1[i - 1] + wave1[i + 1]) +
+                    2 * (wave1[i - 2] + wave1[i + 2]) +
+                    2 * (wave1[i - 3] + wave1[i + 3]);
 
-            value += 8 * (wave1[i - width] + wave1[i + width]);
-            value = (value >> 4) - wave2[i];
+                value += 8 * (wave1[i - width] + wave1[i + width]);
+                value = (value >> 4) - wave2[i];
 
-            int32_t delta = value >> 5;
-            value -= delta;
+                int32_t delta = value >> 5;
+                value -= delta;
 
-            wave2[i] = value;
-        }
-        else {
-            int32_t value = wave1[i - 1] + wave1[i + 1] + wave1[i - width] + wave1[i + width];
+                wave2[i] = value;
+            }
+            else {
+                int32_t value = wave1[i - 1] + wave1[i + 1] + wave1[i - width] + wave1[i + width];
 
-            value = (value >> 1) - wave2[i];
+                value = (value >> 1) - wave2[i];
 
-            int32_t delta = value >> 5;
-            value -= delta;
+                int32_t delta = value >> 5;
+                value -= delta;
 
-            wave2[i] = value;
+                wave2[i] = value;
+            }
+            i++;
         }
-        i++;
     }
 
     lpWaveObject->lpWave1 = wave2;
@@ -228,6 +428,83 @@ void _WaveGetPixel(uint8_t* src, uint8_t* dest, int32_t width) {
     *dest = (uint8_t)sum;
 }
 
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Render one pixel (x, y) of lpDIBitsRender
+// dwDX = energy left of pixel - energy right of pixel
+// dwDY = energy above pixel - energy below pixel
+// Return: 1 if the pixel is refracted (the activity is still ongoing), 0 otherwise
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int _WaveRenderPixel(WAVE_OBJECT* lpWaveObject, int x, int y, uint32_t dwDX, uint32_t dwDY) {
+    uint32_t ByteWidth = lpWaveObject->dwDIByteWidth;
+    uint32_t width = lpWaveObject->dwBmpWidth;
+    uint32_t height = lpWaveObject->dwBmpHeight;
+
+    // PosY = i + energy above pixel - energy below pixel
+    // PosX = j + energy left of pixel - energy right of pixel
+    int posY = y + dwDY;
+    int posX = x + dwDX;
+
+    // _WaveGetPixel reads the lines above and below the source pixel, so the first and last lines can't be a source
+    if (posX >= 0 && posX < width && posY >= 1 && posY < height - 1) {
+        // ptrSource = dwPosY * dwDIByteWidth + dwPosX * 3
+        // ptrDest = i * dwDIByteWidth + j * 3
+        uint8_t* src = lpWaveObject->lpDIBitsSource + (posY * ByteWidth) + (posX * 3);
+        uint8_t* dest = lpWaveObject->lpDIBitsRender + (y * ByteWidth) + (x * 3);
+
+        // Render pixel[ptrDest] = Original pixel[ptrSource]
+        if ((posY * ByteWidth) + (posX * 3) == (y * ByteWidth) + (x * 3)) {
+            uint16_t tempWord = *(uint16_t*)src;  // Load 2 bytes from src
+            src += 2;
+            dest[0] = (uint8_t)tempWord;          // Copy the first byte
+            dest[1] = (uint8_t)(tempWord >> 8);   // Copy the second byte
+            dest[2] = *src;                       // Copy the third byte
+        }
+        // If the source pixel and destination pixel are different, it indicates that the activity is still ongoing
+        else {
+            _WaveGetPixel(src, dest, ByteWidth);
+            _WaveGetPixel(src + 1, dest + 1, ByteWidth);
+            _WaveGetPixel(src + 2, dest + 2, ByteWidth);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Rendering from a tiled Wave1
+// Walked one image line at a time across the tile columns, so lpDIBitsSource and lpDIBitsRender
+// (which stay row-major) are read and written in order. Each tile gives 3 lines of 64 energies.
+// Return: 1 if at least one pixel is refracted
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int _WaveRenderTiled(WAVE_OBJECT* lpWaveObject, uint32_t* wave1) {
+    int dwFlag = 0;
+    uint32_t width = lpWaveObject->dwBmpWidth;
+    uint32_t height = lpWaveObject->dwBmpHeight;
+    uint32_t halo[1 + TILE_W + 1];
+    uint32_t* cur = halo + 1;
+
+    for (uint32_t y = 1; y < height - 1; ++y) {
+        for (uint32_t tx = 0; tx < lpWaveObject->dwTileCols; ++tx) {
+            uint32_t x0 = tx << TILE_SHIFT_X;
+            uint32_t* prev = _WaveTileLine(lpWaveObject, wave1, tx, y - 1);
+            uint32_t* next = _WaveTileLine(lpWaveObject, wave1, tx, y + 1);
+            uint32_t count = _WaveTileHalo(lpWaveObject, wave1, tx, y, cur, 1);
+
+            // Like _WaveRender, the last column of the image is not rendered
+            if (x0 + count >= width)
+                count = width - 1 - x0;
+
+            for (int32_t lx = 0; lx < (int32_t)count; ++lx) {
+                uint32_t dy = prev[lx] - next[lx];
+                uint32_t dx = cur[lx - 1] - cur[lx + 1];
+
+                dwFlag |= _WaveRenderPixel(lpWaveObject, x0 + lx, y, dx, dy);
+            }
+        }
+    }
+    return dwFlag;
+}
+
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 //Rendering subroutine, renders the new frame data into lpDIBitsRender
 //Algorithm:
@@ -241,39 +518,19 @@ void _WaveRender(WAVE_OBJECT* lpWaveObject) {
 
     lpWaveObject->dwFlag |= F_WO_NEED_UPDATE;
     uint32_t* wave1 = lpWaveObject->lpWave1;
-    uint32_t ByteWidth = lpWaveObject->dwDIByteWidth;
     uint32_t width = lpWaveObject->dwBmpWidth;
     uint32_t height = lpWaveObject->dwBmpHeight;
 
-    for (int y = 1; y < height - 1; ++y) {
-        for (int x = 0; x + 1 < width; ++x) {
-            // PosY = i + energy above pixel - energy below pixel
-            // PosX = j + energy left of pixel - energy right of pixel
-            int posY = y + wave1[(y - 1) * width + x] - wave1[(y + 1) * width + x];
-            
-            int posX = x + wave1[y * width + x - 1] - wave1[y * width + x + 1];
-
-            if (posX >= 0 && posX < width && posY >= 0 && posY < height) {
-                // ptrSource = dwPosY * dwDIByteWidth + dwPosX * 3
-                // ptrDest = i * dwDIByteWidth + j * 3
-                uint8_t* src = lpWaveObject->lpDIBitsSource + (posY * ByteWidth) + (posX * 3);
-                uint8_t* dest = lpWaveObject->lpDIBitsRender + (y * ByteWidth) + (x * 3);
-                
-                // Render pixel[ptrDest] = Original pixel[ptrSource]
-                if ((posY * ByteWidth) + (posX * 3) == (y * ByteWidth) + (x * 3)) {
-                    uint16_t tempWord = *(uint16_t*)src;  // Load 2 bytes from src
-                    src += 2;
-                    dest[0] = (uint8_t)tempWord;          // Copy the first byte
-                    dest[1] = (uint8_t)(tempWord >> 8);   // Copy the second byte
-                    dest[2] = *src;                       // Copy the third byte
-                }
-                // If the source pixel and destination pixel are different, it indicates that the activity is still ongoing
-                else {
-                    dwFlag |= 1;
-                    _WaveGetPixel(src, dest, lpWaveObject->dwDIByteWidth);
-                    _WaveGetPixel(src + 1, dest + 1, lpWaveObject->dwDIByteWidth);
-                    _WaveGetPixel(src + 2, dest + 2, lpWaveObject->dwDIByteWidth);
-                }
+    if (lpWaveObject->dwFlag & F_WO_TILED) {
+        dwFlag = _WaveRenderTiled(lpWaveObject, wave1);
+    }
+    else {
+        for (int y = 1; y < height - 1; ++y) {
+            for (int x = 0; x + 1 < width; ++x) {
+                uint32_t dy = wave1[(y - 1) * width + x] - wave1[(y + 1) * width + x];
+                uint32_t dx = wave1[y * width + x - 1] - wave1[y * width + x + 1];
+
+                dwFlag |= _WaveRenderPixel(lpWaveObject, x, y, dx, dy);
             }
         }
     }
@@ -321,7 +578,7 @@ void _WaveDropStone(WAVE_OBJECT* lpWaveObject, uint32_t dwX, uint32_t dwY, uint3
                     int32_t dx = x - dwX;
                     int32_t dy = y - dwY;
                     if ((dx * dx + dy * dy) <= (dwSize * dwSize)) {
-                        lpWaveObject->lpWave1[y * lpWaveObject->dwBmpWidth + x] = dwWeight;
+                        lpWaveObject->lpWave1[_WaveIndex(lpWaveObject, x, y)] = dwWeight;
                     }
                 ++y;
                 }
@@ -332,11 +589,354 @@ void _WaveDropStone(WAVE_OBJECT* lpWaveObject, uint32_t dwX, uint32_t dwY, uint3
     lpWaveObject->dwFlag |= F_WO_ACTIVE; 
 }
 
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Throw dwCount random stones, by batches of WAVE_BATCH_MAX
+// x = dwX + Random(dwXRange), y = 1 + Random(dwBmpHeight - 2)
+// size = 1 + Random(dwSize), energy = dwEnergyBase + Random(dwEnergy)
+// All the parameters of a batch are generated first (one array per parameter), then the stones are thrown
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void _WaveDropBatch(WAVE_OBJECT* lpWaveObject, uint32_t dwCount, uint32_t dwX, uint32_t dwXRange, uint32_t dwSize, uint32_t dwEnergyBase, uint32_t dwEnergy) {
+    while (dwCount) {
+        uint32_t count = dwCount < WAVE_BATCH_MAX ? dwCount : WAVE_BATCH_MAX;
+
+        _WaveRandomBatch(lpWaveObject, lpWaveObject->dwBatchX, count, dwXRange);
+        _WaveRandomBatch(lpWaveObject, lpWaveObject->dwBatchY, count, lpWaveObject->dwBmpHeight - 2);
+        _WaveRandomBatch(lpWaveObject, lpWaveObject->dwBatchSize, count, dwSize);
+        _WaveRandomBatch(lpWaveObject, lpWaveObject->dwBatchEnergy, count, dwEnergy);
+
+        for (uint32_t i = 0; i < count; ++i) {
+            _WaveDropStone(lpWaveObject, dwX + lpWaveObject->dwBatchX[i], lpWaveObject->dwBatchY[i] + 1,
+                lpWaveObject->dwBatchSize[i] + 1, dwEnergyBase + lpWaveObject->dwBatchEnergy[i]);
+        }
+        dwCount -= count;
+    }
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Read exactly dwSize bytes, pipes can return less than asked
+// Return: TRUE if all bytes were read, FALSE on end of file or error
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BOOL _WaveStreamRead(HANDLE hFile, void* lpBuffer, DWORD dwSize) {
+    uint8_t* dest = (uint8_t*)lpBuffer;
+    DWORD dwRead;
+
+    while (dwSize) {
+        if (!ReadFile(hFile, dest, dwSize, &dwRead, NULL) || !dwRead)
+            return FALSE;
+        dest += dwRead;
+        dwSize -= dwRead;
+    }
+    return TRUE;
+}
+
+// Read a Y4M header line (up to '\n') into szLine
+// Return: TRUE if a full line was read
+BOOL _WaveStreamReadLine(HANDLE hFile, char* szLine, uint32_t dwMax) {
+    for (uint32_t i = 0; i + 1 < dwMax; ++i) {
+        if (!_WaveStreamRead(hFile, &szLine[i], 1))
+            return FALSE;
+        if (szLine[i] == '\n') {
+            szLine[i] = 0;
+            return TRUE;
+        }
+    }
+    return FALSE;
+}
+
+uint8_t _WaveClamp(int32_t value) {
+    return (uint8_t)(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Decode the next frame of the stream into lpFrame (same layout as lpDIBitsSource)
+// Y4M: BT.601 conversion
+// B = (298 * (Y - 16) + 516 * (U - 128) + 128) >> 8
+// G = (298 * (Y - 16) - 100 * (U - 128) - 208 * (V - 128) + 128) >> 8
+// R = (298 * (Y - 16) + 409 * (V - 128) + 128) >> 8
+// Return: TRUE if a frame was decoded
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BOOL _WaveStreamDecode(WAVE_OBJECT* lpWaveObject, uint8_t* lpFrame) {
+    HANDLE hFile = lpWaveObject->hStreamFile;
+    uint32_t width = lpWaveObject->dwBmpWidth;
+    uint32_t height = lpWaveObject->dwBmpHeight;
+    uint32_t ByteWidth = lpWaveObject->dwDIByteWidth;
+
+    if (lpWaveObject->dwStreamFormat == WAVE_STREAM_RAW) {
+        // Lines are not padded in the file, read them directly into the frame
+        if (ByteWidth == width * 3)
+            return _WaveStreamRead(hFile, lpFrame, ByteWidth * height);
+
+        for (uint32_t y = 0; y < height; ++y) {
+            if (!_WaveStreamRead(hFile, lpFrame + y * ByteWidth, width * 3))
+                return FALSE;
+        }
+        return TRUE;
+    }
+
+    char szLine[256];
+    if (!_WaveStreamReadLine(hFile, szLine, sizeof(szLine)) || strncmp(szLine, "FRAME", 5))
+        return FALSE;
+
+    uint32_t chromaWidth = (width + 1) >> 1;
+    uint32_t chromaHeight = (height + 1) >> 1;
+    uint8_t* lpY = lpWaveObject->lpStreamYUV;
+    uint8_t* lpU = lpY + width * height;
+    uint8_t* lpV = lpU + chromaWidth * chromaHeight;
+
+    if (!_WaveStreamRead(hFile, lpY, width * height + 2 * chromaWidth * chromaHeight))
+        return FALSE;
+
+    for (uint32_t y = 0; y < height; ++y) {
+        uint8_t* dest = lpFrame + y * ByteWidth;
+        uint8_t* srcY = lpY + y * width;
+        uint8_t* srcU = lpU + (y >> 1) * chromaWidth;
+        uint8_t* srcV = lpV + (y >> 1) * chromaWidth;
+
+        for (uint32_t x = 0; x < width; ++x) {
+            int32_t c = 298 * (srcY[x] - 16) + 128;
+            int32_t d = srcU[x >> 1] - 128;
+            int32_t e = srcV[x >> 1] - 128;
+
+            dest[0] = _WaveClamp((c + 516 * d) >> 8);
+            dest[1] = _WaveClamp((c - 100 * d - 208 * e) >> 8);
+            dest[2] = _WaveClamp((c + 409 * e) >> 8);
+            dest += 3;
+        }
+    }
+    return TRUE;
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Read the Y4M header: "YUV4MPEG2 W<width> H<height> ... [C<chroma>]"
+// The size must be the size of the background image, and the chroma 8 bit 4:2:0
+// (no C tag, or C420, C420jpeg, C420paldv, C420mpeg2; C420p10 etc. are 16 bit per sample)
+// Return: TRUE if the stream can be decoded
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+BOOL _WaveStreamHeader(WAVE_OBJECT* lpWaveObject) {
+    static const char* szChroma420[] = { "420", "420jpeg", "420paldv", "420mpeg2" };
+    char szLine[256];
+    uint32_t dwWidth = 0, dwHeight = 0;
+    bool bChroma420 = true;
+
+    if (!_WaveStreamReadLine(lpWaveObject->hStreamFile, szLine, sizeof(szLine)) || strncmp(szLine, "YUV4MPEG2 ", 10))
+        return FALSE;
+    lpWaveObject->dwStreamOffset = (uint32_t)strlen(szLine) + 1;
+
+    // Each parameter is a space followed by a tag letter and its value
+    for (char* szParam = strchr(szLine, ' '); szParam; szParam = strchr(szParam + 1, ' ')) {
+        if (szParam[1] == 'W')
+            dwWidth = strtoul(szParam + 2, NULL, 10);
+        else if (szParam[1] == 'H')
+            dwHeight = strtoul(szParam + 2, NULL, 10);
+        else if (szParam[1] == 'C') {
+            size_t len = strcspn(szParam + 2, " ");
+            bChroma420 = false;
+            for (int i = 0; i < sizeof(szChroma420) / sizeof(szChroma420[0]); ++i) {
+                if (strlen(szChroma420[i]) == len && !strncmp(szParam + 2, szChroma420[i], len))
+                    bChroma420 = true;
+            }
+        }
+    }
+
+    return dwWidth == lpWaveObject->dwBmpWidth && dwHeight == lpWaveObject->dwBmpHeight && bChroma420;
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Producer thread: waits for a free ring frame, decodes into it and hands it to _WaveStreamNextFrame
+// At the end of a file the stream is rewound to the first frame, at the end of a pipe the thread stops
+// (the last frame stays displayed)
+// For a pipe, the thread first waits for the writer to connect (named pipe) and reads the Y4M header,
+// so _WaveStreamOpen and the window never wait for the writer.
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+DWORD WINAPI _WaveStreamThread(LPVOID lpParam) {
+    WAVE_OBJECT* lpWaveObject = (WAVE_OBJECT*)lpParam;
+    HANDLE hFile = lpWaveObject->hStreamFile;
+
+    if (lpWaveObject->dwFlag & F_WO_STREAM_SERVER) {
+        if (!ConnectNamedPipe(hFile, NULL) && GetLastError() != ERROR_PIPE_CONNECTED)
+            return 0;
+    }
+
+    if (lpWaveObject->dwStreamFormat == WAVE_STREAM_Y4M && GetFileType(hFile) != FILE_TYPE_DISK) {
+        if (!_WaveStreamHeader(lpWaveObject))
+            return 0;
+    }
+
+    while (!lpWaveObject->bStreamStop) {
+        WaitForSingleObject(lpWaveObject->hStreamFree, INFINITE);
+        if (lpWaveObject->bStreamStop)
+            break;
+
+        uint8_t* lpFrame = lpWaveObject->lpStreamRing[lpWaveObject->dwStreamWrite];
+        BOOL bDecoded = _WaveStreamDecode(lpWaveObject, lpFrame);
+
+        if (!bDecoded && GetFileType(hFile) == FILE_TYPE_DISK && !lpWaveObject->bStreamStop) {
+            SetFilePointer(hFile, lpWaveObject->dwStreamOffset, NULL, FILE_BEGIN);
+            bDecoded = _WaveStreamDecode(lpWaveObject, lpFrame);
+        }
+        if (!bDecoded)
+            break;
+
+        lpWaveObject->dwStreamWrite = (lpWaveObject->dwStreamWrite + 1) % WAVE_STREAM_RING;
+        InterlockedIncrement(&lpWaveObject->dwStreamReady);
+    }
+    return 0;
+}
+
+// _WaveRender does not write the first and last lines and the last column, copy them from lpFrame as is
+void _WaveStreamBorders(WAVE_OBJECT* lpWaveObject, uint8_t* lpFrame) {
+    uint32_t ByteWidth = lpWaveObject->dwDIByteWidth;
+    uint32_t lastLine = (lpWaveObject->dwBmpHeight - 1) * ByteWidth;
+    uint32_t lastColumn = (lpWaveObject->dwBmpWidth - 1) * 3;
+
+    CopyMemory(lpWaveObject->lpDIBitsRender, lpFrame, ByteWidth);
+    CopyMemory(lpWaveObject->lpDIBitsRender + lastLine, lpFrame + lastLine, ByteWidth);
+    for (uint32_t y = 1; y < lpWaveObject->dwBmpHeight - 1; ++y) {
+        uint32_t i = y * ByteWidth + lastColumn;
+        lpWaveObject->lpDIBitsRender[i] = lpFrame[i];
+        lpWaveObject->lpDIBitsRender[i + 1] = lpFrame[i + 1];
+        lpWaveObject->lpDIBitsRender[i + 2] = lpFrame[i + 2];
+    }
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Display the next decoded frame, if the producer has one ready (never waits)
+// The frame becomes lpDIBitsSource as is, the previously displayed frame goes back to the producer
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void _WaveStreamNextFrame(WAVE_OBJECT* lpWaveObject) {
+    if (!(lpWaveObject->dwFlag & F_WO_STREAM) || !lpWaveObject->dwStreamReady)
+        return;
+
+    uint8_t* lpFrame = lpWaveObject->lpStreamRing[lpWaveObject->dwStreamRead];
+    lpWaveObject->dwStreamRead = (lpWaveObject->dwStreamRead + 1) % WAVE_STREAM_RING;
+    InterlockedDecrement(&lpWaveObject->dwStreamReady);
+
+    if (lpWaveObject->dwFlag & F_WO_STREAM_FRAME)
+        ReleaseSemaphore(lpWaveObject->hStreamFree, 1, NULL);
+
+    lpWaveObject->lpDIBitsSource = lpFrame;
+    lpWaveObject->dwFlag |= F_WO_STREAM_FRAME | F_WO_ACTIVE;
+    _WaveStreamBorders(lpWaveObject, lpFrame);
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Stop the stream and restore the original background image
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+void _WaveStreamClose(WAVE_OBJECT* lpWaveObject) {
+    if (!(lpWaveObject->dwFlag & F_WO_STREAM)) return;
+
+    if (lpWaveObject->hStreamThread) {
+        // Wake up the producer, whether it waits for a free frame or is blocked reading a pipe
+        InterlockedExchange(&lpWaveObject->bStreamStop, 1);
+        ReleaseSemaphore(lpWaveObject->hStreamFree, 1, NULL);
+        while (WaitForSingleObject(lpWaveObject->hStreamThread, 10) == WAIT_TIMEOUT)
+            CancelSynchronousIo(lpWaveObject->hStreamThread);
+        CloseHandle(lpWaveObject->hStreamThread);
+    }
+
+    if (lpWaveObject->hStreamFree)
+        CloseHandle(lpWaveObject->hStreamFree);
+
+    if (lpWaveObject->hStreamFile && lpWaveObject->hStreamFile != GetStdHandle(STD_INPUT_HANDLE))
+        CloseHandle(lpWaveObject->hStreamFile);
+
+    for (int i = 0; i < WAVE_STREAM_RING; ++i) {
+        if (lpWaveObject->lpStreamRing[i])
+            GlobalFree(lpWaveObject->lpStreamRing[i]);
+        lpWaveObject->lpStreamRing[i] = NULL;
+    }
+
+    if (lpWaveObject->lpStreamYUV)
+        GlobalFree(lpWaveObject->lpStreamYUV);
+
+    // Back to the original image, including the borders a video frame has put in lpDIBitsRender
+    if (lpWaveObject->dwFlag & F_WO_STREAM_FRAME)
+        _WaveStreamBorders(lpWaveObject, lpWaveObject->lpStreamStill);
+    lpWaveObject->lpDIBitsSource = lpWaveObject->lpStreamStill;
+    lpWaveObject->hStreamFile = NULL;
+    lpWaveObject->hStreamThread = NULL;
+    lpWaveObject->hStreamFree = NULL;
+    lpWaveObject->lpStreamStill = NULL;
+    lpWaveObject->lpStreamYUV = NULL;
+    lpWaveObject->dwStreamReady = 0;
+    lpWaveObject->bStreamStop = 0;
+    lpWaveObject->dwFlag &= ~(F_WO_STREAM | F_WO_STREAM_FRAME | F_WO_STREAM_SERVER);
+    lpWaveObject->dwFlag |= F_WO_ACTIVE;
+}
+
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+// Start streaming the background image from a file or a pipe
+// Parameters: szFile = File or pipe name, NULL = standard input, dwFormat = WAVE_STREAM_xxx
+// Returns: eax = 0 Success, = 1 Failure
+//>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+int _WaveStreamOpen(WAVE_OBJECT* lpWaveObject, LPCTSTR szFile, uint32_t dwFormat) {
+    _WaveStreamClose(lpWaveObject);
+
+    if (dwFormat != WAVE_STREAM_RAW && dwFormat != WAVE_STREAM_Y4M)
+        return 1;
+
+    lpWaveObject->dwFlag |= F_WO_STREAM;
+    lpWaveObject->dwStreamFormat = dwFormat;
+    lpWaveObject->dwStreamRead = 0;
+    lpWaveObject->dwStreamWrite = 0;
+    lpWaveObject->dwStreamOffset = 0;
+    lpWaveObject->lpStreamStill = lpWaveObject->lpDIBitsSource;
+
+    // \\.\pipe\name: we are the server, the writer (e.g. ffmpeg) opens the pipe as a client
+    if (szFile && !_tcsnicmp(szFile, _T("\\\\.\\pipe\\"), 9)) {
+        lpWaveObject->dwFlag |= F_WO_STREAM_SERVER;
+        lpWaveObject->hStreamFile = CreateNamedPipe(szFile, PIPE_ACCESS_INBOUND, PIPE_TYPE_BYTE | PIPE_READMODE_BYTE | PIPE_WAIT, 1, 0, 1 << 20, 0, NULL);
+    }
+    else if (szFile)
+        lpWaveObject->hStreamFile = CreateFile(szFile, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    else
+        lpWaveObject->hStreamFile = GetStdHandle(STD_INPUT_HANDLE);
+
+    if (lpWaveObject->hStreamFile == INVALID_HANDLE_VALUE || !lpWaveObject->hStreamFile) {
+        lpWaveObject->hStreamFile = NULL;
+        _WaveStreamClose(lpWaveObject);
+        return 1;
+    }
+
+    // Y4M: the header of a file is checked now, the header of a pipe by _WaveStreamThread
+    if (dwFormat == WAVE_STREAM_Y4M) {
+        uint32_t chromaSize = ((lpWaveObject->dwBmpWidth + 1) >> 1) * ((lpWaveObject->dwBmpHeight + 1) >> 1);
+        lpWaveObject->lpStreamYUV = (uint8_t*)GlobalAlloc(GPTR, lpWaveObject->dwBmpWidth * lpWaveObject->dwBmpHeight + 2 * chromaSize);
+
+        if (!lpWaveObject->lpStreamYUV || (GetFileType(lpWaveObject->hStreamFile) == FILE_TYPE_DISK && !_WaveStreamHeader(lpWaveObject))) {
+            _WaveStreamClose(lpWaveObject);
+            return 1;
+        }
+    }
+
+    // Allocate the ring of source frames once, frames are then only swapped
+    size_t pixelBufferSize = lpWaveObject->dwDIByteWidth * lpWaveObject->dwBmpHeight;
+    for (int i = 0; i < WAVE_STREAM_RING; ++i) {
+        lpWaveObject->lpStreamRing[i] = (uint8_t*)GlobalAlloc(GPTR, pixelBufferSize);
+        if (!lpWaveObject->lpStreamRing[i]) {
+            _WaveStreamClose(lpWaveObject);
+            return 1;
+        }
+    }
+
+    // All the frames of the ring are free, the original image is displayed until the first frame is ready
+    lpWaveObject->hStreamFree = CreateSemaphore(NULL, WAVE_STREAM_RING, WAVE_STREAM_RING + 1, NULL);
+    if (lpWaveObject->hStreamFree)
+        lpWaveObject->hStreamThread = CreateThread(NULL, 0, _WaveStreamThread, lpWaveObject, 0, NULL);
+
+    if (!lpWaveObject->hStreamThread) {
+        _WaveStreamClose(lpWaveObject);
+        return 1;
+    }
+    return 0;
+}
+
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 // Timer procedure for calculating diffusion data, rendering bitmaps, updating the window, and handling special effects
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void _WaveTimerProc(HWND hWnd, UINT uMsg, WAVE_OBJECT* lpWaveObject, DWORD dwTime) {
 
+    _WaveStreamNextFrame(lpWaveObject);
     _WaveSpread(lpWaveObject);
     _WaveRender(lpWaveObject);
 
@@ -350,6 +950,7 @@ void _WaveTimerProc(HWND hWnd, UINT uMsg, WAVE_OBJECT* lpWaveObject, DWORD dwTim
     if ((lpWaveObject->dwFlag & F_WO_EFFECT) != 0) {
         switch (lpWaveObject->dwEffectType) {
         // Type = 1 Raindrops, Param1 = Speed (0 is the fastest, larger values are slower), Param2 = Raindrop Size, Param3 = Energy
+        // At most one drop per refresh, nothing to batch: stays on _WaveRandom
         case 1: {
             if (!lpWaveObject->dwEffectParam1 || !_WaveRandom(lpWaveObject, lpWaveObject->dwEffectParam1)) {
                 int x = _WaveRandom(lpWaveObject, lpWaveObject->dwBmpWidth - 2) + 1;
@@ -394,16 +995,50 @@ void _WaveTimerProc(HWND hWnd, UINT uMsg, WAVE_OBJECT* lpWaveObject, DWORD dwTim
         }
         // Type = 3 Waves, Param1 = Density, Param2 = Size, Param3 = Energy
         case 3: {
-            for (int i = 0; i <= lpWaveObject->dwEffectParam1; ++i) {
-                int x = _WaveRandom(lpWaveObject, lpWaveObject->dwBmpWidth - 2) + 1;
-                int y = _WaveRandom(lpWaveObject, lpWaveObject->dwBmpHeight - 2) + 1;
-                int size = _WaveRandom(lpWaveObject, lpWaveObject->dwEffectParam2) + 1;
-                int energy = _WaveRandom(lpWaveObject, lpWaveObject->dwEffectParam3);
-
-                _WaveDropStone(lpWaveObject, x, y, size, energy);
+            _WaveDropBatch(lpWaveObject, lpWaveObject->dwEffectParam1 + 1, 1, lpWaveObject->dwBmpWidth - 2, lpWaveObject->dwEffectParam2, 0, lpWaveObject->dwEffectParam3);
+            break;
             }
+        // Type = 4 Rain curtain, Param1 = Raindrops per refresh, Param2 = Raindrop Size, Param3 = Energy
+        // The curtain is 1/8 of the image wide and moves 2 pixels to the right each refresh
+        case 4: {
+            uint32_t band = (lpWaveObject->dwBmpWidth - 2) / 8 + 1;
+
+            _WaveDropBatch(lpWaveObject, lpWaveObject->dwEffectParam1, lpWaveObject->dwEff4X, band, lpWaveObject->dwEffectParam2, 50, lpWaveObject->dwEffectParam3);
+
+            lpWaveObject->dwEff4X += 2;
+            if (lpWaveObject->dwEff4X + band > lpWaveObject->dwBmpWidth - 2)
+                lpWaveObject->dwEff4X = 1;
             break;
+        }
+        // Type = 5 Boats, Param1 = Number of boats, Param2 = Size, Param3 = Energy
+        // Same moves as type 2, all the boats move first, then they all drop their stone
+        case 5: {
+            if ((++lpWaveObject->dwEff2Flip & 1) == 0) {
+                int32_t maxX = lpWaveObject->dwBmpWidth - 1;
+                int32_t maxY = lpWaveObject->dwBmpHeight - 1;
+
+                for (uint32_t i = 0; i < lpWaveObject->dwEff5Count; ++i) {
+                    int32_t x = lpWaveObject->dwEff5X[i] + lpWaveObject->dwEff5XAdd[i];
+                    int32_t y = lpWaveObject->dwEff5Y[i] + lpWaveObject->dwEff5YAdd[i];
+                    int32_t xAdd = lpWaveObject->dwEff5XAdd[i];
+                    int32_t yAdd = lpWaveObject->dwEff5YAdd[i];
+
+                    if (x < 1) { x = 1 - x; xAdd = -xAdd; }
+                    if (y < 1) { y = 1 - y; yAdd = -yAdd; }
+                    if (x >= maxX) { x = 2 * maxX - x; xAdd = -xAdd; }
+                    if (y >= maxY) { y = 2 * maxY - y; yAdd = -yAdd; }
+
+                    lpWaveObject->dwEff5X[i] = x;
+                    lpWaveObject->dwEff5Y[i] = y;
+                    lpWaveObject->dwEff5XAdd[i] = xAdd;
+                    lpWaveObject->dwEff5YAdd[i] = yAdd;
+                }
+                for (uint32_t i = 0; i < lpWaveObject->dwEff5Count; ++i) {
+                    _WaveDropStone(lpWaveObject, lpWaveObject->dwEff5X[i], lpWaveObject->dwEff5Y[i], lpWaveObject->dwEffectParam2, lpWaveObject->dwEffectParam3);
+                }
             }
+            break;
+        }
         }
     }
 }
@@ -412,6 +1047,8 @@ void _WaveTimerProc(HWND hWnd, UINT uMsg, WAVE_OBJECT* lpWaveObject, DWORD dwTim
 // Release the object
 //>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
 void _WaveFree(WAVE_OBJECT* lpWaveObject) {
+    _WaveStreamClose(lpWaveObject);
+
     if (lpWaveObject->hDcRender)
         DeleteDC(lpWaveObject->hDcRender);
 
@@ -447,13 +1084,21 @@ int _WaveInit(WAVE_OBJECT* lpWaveObject, HWND hWnd, HBITMAP hBmp, DWORD dwSpeed,
     RtlZeroMemory(lpWaveObject, sizeof(WAVE_OBJECT));
 
     // Set the elliptical flag if dwType is non-zero
-    if (dwType) {
+    if (dwType & WAVE_TYPE_ELLIPSE) {
         lpWaveObject->dwFlag |= F_WO_ELLIPSE;
     }
 
+    // Set the tiled layout flag for the wave buffers
+    if (dwType & WAVE_TYPE_TILED) {
+        lpWaveObject->dwFlag |= F_WO_TILED;
+    }
+
     // Assign window handle and set random seed
     lpWaveObject->hWnd = hWnd;
     lpWaveObject->dwRandom = GetTickCount();
+    for (int lane = 0; lane < WAVE_RANDOM_LANES; ++lane) {
+        lpWaveObject->dwRandomLanes[lane] = _WaveRandom(lpWaveObject, 0);
+    }
 
     // Retrieve bitmap dimensions
     if (!GetObject(hBmp, sizeof(BITMAP), &stBmp)) {
@@ -483,8 +1128,13 @@ int _WaveInit(WAVE_OBJECT* lpWaveObject, HWND hWnd, HBITMAP hBmp, DWORD dwSpeed,
     lpWaveObject->hBmpRender = CreateCompatibleBitmap(hDC, lpWaveObject->dwBmpWidth, lpWaveObject->dwBmpHeight);
     SelectObject(lpWaveObject->hDcRender, lpWaveObject->hBmpRender);
 
-    // Allocate wave energy buffers
+    // Allocate wave energy buffers, the tiled layout is padded to whole tiles (padding stays at zero energy)
     size_t waveBufferSize = lpWaveObject->dwWaveByteWidth * lpWaveObject->dwBmpHeight;
+    if (lpWaveObject->dwFlag & F_WO_TILED) {
+        lpWaveObject->dwTileCols = (lpWaveObject->dwBmpWidth + TILE_W - 1) >> TILE_SHIFT_X;
+        lpWaveObject->dwTileRows = (lpWaveObject->dwBmpHeight + TILE_H - 1) >> TILE_SHIFT_Y;
+        waveBufferSize = (size_t)lpWaveObject->dwTileCols * lpWaveObject->dwTileRows * TILE_SIZE * sizeof(uint32_t);
+    }
     lpWaveObject->lpWave1 = (uint32_t*)GlobalAlloc(GPTR, waveBufferSize);
     lpWaveObject->lpWave2 = (uint32_t*)GlobalAlloc(GPTR, waveBufferSize);
 
@@ -550,6 +1200,30 @@ void _WaveEffect(WAVE_OBJECT* lpWaveObject, uint32_t dwType, uint32_t dwParam1,
             lpWaveObject->dwEff2X = _WaveRandom(lpWaveObject, lpWaveObject->dwBmpWidth - 2) + 1;
             lpWaveObject->dwEff2Y = _WaveRandom(lpWaveObject, lpWaveObject->dwBmpHeight - 2) + 1;
         }
+        // Rain curtain special effect
+        else if (dwType == 4)
+        {
+            lpWaveObject->dwEff4X = 1;
+        }
+        // Boats special effect: random start positions, speeds 1~4 in random directions
+        else if (dwType == 5)
+        {
+            uint32_t count = dwParam1 < 1 ? 1 : (dwParam1 > WAVE_BOATS_MAX ? WAVE_BOATS_MAX : dwParam1);
+
+            lpWaveObject->dwEff5Count = count;
+            _WaveRandomBatch(lpWaveObject, (uint32_t*)lpWaveObject->dwEff5X, count, lpWaveObject->dwBmpWidth - 2);
+            _WaveRandomBatch(lpWaveObject, (uint32_t*)lpWaveObject->dwEff5Y, count, lpWaveObject->dwBmpHeight - 2);
+            _WaveRandomBatch(lpWaveObject, (uint32_t*)lpWaveObject->dwEff5XAdd, count, 8);
+            _WaveRandomBatch(lpWaveObject, (uint32_t*)lpWaveObject->dwEff5YAdd, count, 8);
+
+            for (uint32_t i = 0; i < count; ++i) {
+                lpWaveObject->dwEff5X[i] += 1;
+                lpWaveObject->dwEff5Y[i] += 1;
+                // Random(8): bit 0 = direction, bits 1~2 = speed - 1
+                lpWaveObject->dwEff5XAdd[i] = (lpWaveObject->dwEff5XAdd[i] & 1) ? -((lpWaveObject->dwEff5XAdd[i] >> 1) + 1) : (lpWaveObject->dwEff5XAdd[i] >> 1) + 1;
+                lpWaveObject->dwEff5YAdd[i] = (lpWaveObject->dwEff5YAdd[i] & 1) ? -((lpWaveObject->dwEff5YAdd[i] >> 1) + 1) : (lpWaveObject->dwEff5YAdd[i] >> 1) + 1;
+            }
+        }
         lpWaveObject->dwEffectType = dwType;
         lpWaveObject->dwEffectParam1 = dwParam1;
         lpWaveObject->dwEffectParam2 = dwParam2;
@@ -34,6 +34,8 @@ INT_PTR CALLBACK DlgProc(HWND hWin, UINT uMsg, WPARAM wParam, LPARAM lParam) {
         
         // Elliptical water ripples (used for perspective effects)
         //if (_WaveInit(&stWaveObj, hWin, hBitmap, 30, 1)) {
+        // Circular water ripples, wave buffers stored in 64x16 tiles
+        //if (_WaveInit(&stWaveObj, hWin, hBitmap, 30, WAVE_TYPE_TILED)) {
         // Circular water ripples
         if (_WaveInit(&stWaveObj, hWin, hBitmap, 30, 0)) {
             MessageBox(hWin, _T(szError), _T(szTitle), MB_OK | MB_ICONSTOP);
@@ -44,6 +46,13 @@ INT_PTR CALLBACK DlgProc(HWND hWin, UINT uMsg, WPARAM wParam, LPARAM lParam) {
         _WaveEffect(&stWaveObj, 1, 5, 4, 250); // Rain
         //_WaveEffect(&stWaveObj, 2, 4, 2, 400); // Motorboat
         //_WaveEffect(&stWaveObj, 3, 100, 3, 7); // Wind Waves
+        //_WaveEffect(&stWaveObj, 4, 6, 3, 200); // Rain Curtain
+        //_WaveEffect(&stWaveObj, 5, 4, 2, 400); // Motorboats
+
+        // Ripples over a video, the frames must have the size of the background image
+        //_WaveStreamOpen(&stWaveObj, _T("video.y4m"), WAVE_STREAM_Y4M);
+        // or from ffmpeg: ffmpeg -i video.mp4 -s <width>x<height> -pix_fmt yuv420p -f yuv4mpegpipe \\.\pipe\ripple
+        //_WaveStreamOpen(&stWaveObj, _T("\\\\.\\pipe\\ripple"), WAVE_STREAM_Y4M);
         break;
 
     case WM_PAINT:
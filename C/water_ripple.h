@@ -6,6 +6,20 @@
 #define LOGO                        1002
 #define MYICON                      1003
 
+// _WaveInit dwType bits
+#define WAVE_TYPE_ELLIPSE           0x0001  // Elliptical water ripples (perspective effect)
+#define WAVE_TYPE_TILED             0x0002  // Store wave energy in 64x16 tiles instead of row-major
+
+// _WaveStreamOpen dwFormat values
+#define WAVE_STREAM_RAW             1       // Raw BGR24 frames, top-down, dwBmpWidth * 3 bytes per line
+#define WAVE_STREAM_Y4M             2       // YUV4MPEG2 stream, 4:2:0 chroma
+#define WAVE_STREAM_RING            3       // Number of pre-allocated source frames
+
+// Batched effects
+#define WAVE_RANDOM_LANES           8       // Number of parallel random number streams
+#define WAVE_BATCH_MAX              256     // Drops generated per batch, multiple of WAVE_RANDOM_LANES
+#define WAVE_BOATS_MAX              16      // Maximum number of boats of effect 5
+
 // WAVE_OBJECT structure definition
 typedef struct WAVE_OBJECT {
 HWND hWnd;              // Window handle
@@ -24,6 +38,8 @@ uint32_t dwBmpWidth;
 uint32_t dwBmpHeight;
 uint32_t dwDIByteWidth;    // = (dwBmpWidth * 3 + 3) & ~3
 uint32_t dwWaveByteWidth;  // = dwBmpWidth * 4
+uint32_t dwTileCols;       // Tiled layout only: = (dwBmpWidth + 63) / 64
+uint32_t dwTileRows;       // Tiled layout only: = (dwBmpHeight + 15) / 16
 uint32_t dwRandom;
 
 // Special Effect Parameters
@@ -39,6 +55,37 @@ int32_t dwEff2XAdd;
 int32_t dwEff2YAdd;
 uint32_t dwEff2Flip;
 
+// Used for rain curtain effect
+uint32_t dwEff4X;          // Left side of the curtain
+
+// Used for multiple boats effect
+uint32_t dwEff5Count;
+int32_t dwEff5X[WAVE_BOATS_MAX];
+int32_t dwEff5Y[WAVE_BOATS_MAX];
+int32_t dwEff5XAdd[WAVE_BOATS_MAX];
+int32_t dwEff5YAdd[WAVE_BOATS_MAX];
+
+// Batched effects, one random number stream per lane and one array per drop parameter
+uint32_t dwRandomLanes[WAVE_RANDOM_LANES];
+uint32_t dwBatchX[WAVE_BATCH_MAX];
+uint32_t dwBatchY[WAVE_BATCH_MAX];
+uint32_t dwBatchSize[WAVE_BATCH_MAX];
+uint32_t dwBatchEnergy[WAVE_BATCH_MAX];
+
+// Streaming background source
+HANDLE hStreamFile;
+HANDLE hStreamThread;      // Producer thread, decodes frames into lpStreamRing
+HANDLE hStreamFree;        // Semaphore, number of ring frames the producer may fill
+volatile LONG dwStreamReady; // Number of decoded frames not displayed yet
+volatile LONG bStreamStop;
+uint8_t* lpStreamRing[WAVE_STREAM_RING]; // Source frames, same layout as lpDIBitsSource
+uint8_t* lpStreamStill;    // Original lpDIBitsSource, restored when the stream is closed
+uint8_t* lpStreamYUV;      // Y4M frame before conversion to BGR
+uint32_t dwStreamFormat;
+uint32_t dwStreamRead;     // Next ring frame to display
+uint32_t dwStreamWrite;    // Next ring frame to decode
+uint32_t dwStreamOffset;   // Position of the first frame in the file (rewind on end of file)
+
 BITMAPINFO stBmpInfo;   // Bitmap information structure
 } WAVE_OBJECT;
 
@@ -48,4 +95,6 @@ int _WaveInit(WAVE_OBJECT* lpWaveObject, HWND hWnd, HBITMAP hBmp, DWORD dwSpeed,
 void _WaveEffect(WAVE_OBJECT* lpWaveObject, uint32_t dwType, uint32_t dwParam1, uint32_t dwParam2, uint32_t dwParam3);
 void _WaveUpdateFrame(WAVE_OBJECT* lpWaveObject, HDC _hDc, BOOL _bIfForce);
 void _WaveFree(WAVE_OBJECT* lpWaveObject);
+int _WaveStreamOpen(WAVE_OBJECT* lpWaveObject, LPCTSTR szFile, uint32_t dwFormat);
+void _WaveStreamClose(WAVE_OBJECT* lpWaveObject);
 
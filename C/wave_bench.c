@@ -0,0 +1,124 @@
+/*********************************************************************************
+ * Console benchmark of the wave buffer layouts (row-major and WAVE_TYPE_TILED)
+ *
+ * Build from a Developer Command Prompt:
+ *    cl /O2 wave_bench.c WaveObject.c user32.lib gdi32.lib
+ * Usage:
+ *    wave_bench [width height ticks]     (default 7680 4320 20)
+ *
+ * For each ripple type, one object per layout is created and both get the same stones.
+ * Every tick throws one more stone, then times _WaveSpread and _WaveRender on both objects,
+ * alternating which one goes first, so that a slow period of the machine costs the same to both.
+ * The checksums of the energy (read in x, y order through _WaveIndex) and of the rendered pixels
+ * must be the same for both layouts.
+ * Only times are measured; cache and TLB misses need a profiler with hardware counters
+ * (VTune, WPR / xperf with PMC sampling) run on this program.
+ *********************************************************************************/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <windows.h>
+#include <tchar.h>
+#include "water_ripple.h"
+
+// Internal routines of WaveObject.c
+void _WaveSpread(WAVE_OBJECT* lpWaveObject);
+void _WaveRender(WAVE_OBJECT* lpWaveObject);
+void _WaveDropStone(WAVE_OBJECT* lpWaveObject, uint32_t dwX, uint32_t dwY, uint32_t dwSize, uint32_t dwWeight);
+uint32_t _WaveIndex(WAVE_OBJECT* lpWaveObject, uint32_t x, uint32_t y);
+
+// [0] = row-major, [1] = tiled
+WAVE_OBJECT stWaveObj[2];
+
+// Stone positions must not depend on the layout, use our own generator
+uint32_t _BenchRandom(uint32_t* lpSeed, uint32_t dwMax) {
+    *lpSeed = *lpSeed * 1664525 + 1013904223;
+    return (uint32_t)(((uint64_t)*lpSeed * dwMax) >> 32);
+}
+
+void _BenchDrop(uint32_t* lpSeed) {
+    uint32_t x = _BenchRandom(lpSeed, stWaveObj[0].dwBmpWidth - 2) + 1;
+    uint32_t y = _BenchRandom(lpSeed, stWaveObj[0].dwBmpHeight - 2) + 1;
+    uint32_t size = _BenchRandom(lpSeed, 5) + 1;
+    uint32_t weight = _BenchRandom(lpSeed, 250) + 50;
+
+    _WaveDropStone(&stWaveObj[0], x, y, size, weight);
+    _WaveDropStone(&stWaveObj[1], x, y, size, weight);
+}
+
+uint32_t _BenchChecksum(WAVE_OBJECT* lpWaveObject) {
+    uint32_t sum = 0;
+    for (uint32_t y = 0; y < lpWaveObject->dwBmpHeight; ++y)
+        for (uint32_t x = 0; x < lpWaveObject->dwBmpWidth; ++x)
+            sum = sum * 31 + lpWaveObject->lpWave1[_WaveIndex(lpWaveObject, x, y)];
+    for (uint32_t i = 0; i < lpWaveObject->dwDIByteWidth * lpWaveObject->dwBmpHeight; ++i)
+        sum = sum * 31 + lpWaveObject->lpDIBitsRender[i];
+    return sum;
+}
+
+int main(int argc, char* argv[]) {
+    uint32_t width = 7680, height = 4320, ticks = 20;
+    LARGE_INTEGER freq, t0, t1;
+
+    if (argc == 4) {
+        width = strtoul(argv[1], NULL, 10);
+        height = strtoul(argv[2], NULL, 10);
+        ticks = strtoul(argv[3], NULL, 10);
+    }
+    QueryPerformanceFrequency(&freq);
+
+    HDC hDC = GetDC(NULL);
+    HBITMAP hBmp = CreateCompatibleBitmap(hDC, width, height);
+    ReleaseDC(NULL, hDC);
+
+    // Message-only window: _WaveInit paints its first frame in it (not on the desktop),
+    // and its timers have a window, so _WaveFree's KillTimer removes them
+    HWND hWnd = CreateWindowEx(0, _T("STATIC"), NULL, 0, 0, 0, 0, 0, HWND_MESSAGE, NULL, NULL, NULL);
+
+    printf("%ux%u, %u ticks, ms/tick\n", width, height, ticks);
+    for (DWORD dwType = 0; dwType <= WAVE_TYPE_ELLIPSE; ++dwType) {
+        double spread[2] = { 0, 0 }, render[2] = { 0, 0 };
+        uint32_t seed = 12345;
+
+        if (_WaveInit(&stWaveObj[0], hWnd, hBmp, 1000, dwType) ||
+            _WaveInit(&stWaveObj[1], hWnd, hBmp, 1000, dwType | WAVE_TYPE_TILED)) {
+            printf("_WaveInit failed\n");
+            return 1;
+        }
+        for (int i = 0; i < 200; ++i)
+            _BenchDrop(&seed);
+
+        for (uint32_t i = 0; i < ticks; ++i) {
+            _BenchDrop(&seed);
+            for (int j = 0; j < 2; ++j) {
+                int layout = (i + j) & 1;
+                QueryPerformanceCounter(&t0);
+                _WaveSpread(&stWaveObj[layout]);
+                QueryPerformanceCounter(&t1);
+                spread[layout] += (double)(t1.QuadPart - t0.QuadPart);
+            }
+            for (int j = 0; j < 2; ++j) {
+                int layout = (i + j) & 1;
+                QueryPerformanceCounter(&t0);
+                _WaveRender(&stWaveObj[layout]);
+                QueryPerformanceCounter(&t1);
+                render[layout] += (double)(t1.QuadPart - t0.QuadPart);
+            }
+        }
+
+        double scale = 1000.0 / freq.QuadPart / ticks;
+        printf("%-8s spread row-major %8.2f  tiled %8.2f  (x%.2f)   render row-major %8.2f  tiled %8.2f  (x%.2f)\n",
+            dwType ? "ellipse" : "circle",
+            spread[0] * scale, spread[1] * scale, spread[1] / spread[0],
+            render[0] * scale, render[1] * scale, render[1] / render[0]);
+        printf("         checksum row-major %08x  tiled %08x\n", _BenchChecksum(&stWaveObj[0]), _BenchChecksum(&stWaveObj[1]));
+
+        _WaveFree(&stWaveObj[0]);
+        _WaveFree(&stWaveObj[1]);
+    }
+
+    DestroyWindow(hWnd);
+    DeleteObject(hBmp);
+    return 0;
+}